@@ -28,7 +28,7 @@
  *
  * author: Stefan Buettcher
  * created: 2004-11-26
- * changed: 2009-02-01
+ * changed: 2026-10-16
  **/
 
 
@@ -46,6 +46,7 @@
 #include <unistd.h>
 #include "client_connection.h"
 #include "conn_daemon.h"
+#include "query_executor.h"
 #include "../index/fakeindex.h"
 #include "../misc/all.h"
 #include "../query/query.h"
@@ -68,6 +69,7 @@ void ClientConnection::initialize(Index *index, int fd, uid_t userID) {
 	this->fd = fd;
 	this->userID = userID;
 	getConfigurationBool("FORK_ON_QUERY", &forkOnQuery, false);
+	useQueryThreadPool = true;
 } // end of initialize(Index*, int, uid_t)
 
 
@@ -195,56 +197,9 @@ void ClientConnection::run() {
 		bufferSize -= ((long)newLine) - ((long)buffer);
 		memmove(buffer, newLine, bufferSize);
 
-		// remove trailing whitespace characters
-		int len = strlen(line);
-		if (len > 0)
-			while ((line[len - 1] > 0) && (line[len - 1] <= ' ')) {
-				line[--len] = 0;
-				if (len == 0)
-					break;
-			}
-
 		// number of bytes written in response to the current line;
 		// -1 is used to indicate that the socket has been closed
-		int written = -1;
-
-		if (len == 0) {
-			sprintf(line, "@%d-%s\n", 1, "Empty line.");
-			written = sendMessage(line);
-		}
-		else if (len > Query::MAX_QUERY_LENGTH) {
-			sprintf(line, "@%d-%s\n", 1, "Query too long.");
-			written = sendMessage(line);
-		}
-		else if (strncasecmp(line, "@login ", 7) == 0) {
-			bool result = authenticate(&line[7]);
-			if (result)
-				sprintf(line, "@%d-%s\n", 0, "Authenticated.");
-			else
-				sprintf(line, "@%d-%s\n", 1, "Authentication failed.");
-			written = sendMessage(line);
-		}
-		else if (strcasecmp(line, "@whoami") == 0) {
-			sprintf(line, "%d\n@%d-%s\n", userID, 0, "Ok.");
-			written = sendMessage(line);
-		}
-		else if (strcasecmp(line, "@nofork") == 0) {
-			if ((userID == Index::SUPERUSER) || (userID == geteuid())) {
-				forkOnQuery = false;
-				sprintf(line, "@%d-%s\n", 0, "Fork-on-query disabled.");
-				written = sendMessage(line);
-			}
-			else
-				written = 0;
-		}
-		else if ((strcasecmp(line, "@quit") == 0) || (strcasecmp(line, "@exit") == 0)) {
-			// close connection
-			written = -1;
-		}
-		else {
-			// process the command found in the line just read
-			written = processLine(line);
-		}
+		int written = processInputLine(line);
 
 		// if nothing could be written to the socket: stop execution
 		if (written < 0)
@@ -262,6 +217,62 @@ void ClientConnection::run() {
 } // end of run()
 
 
+int ClientConnection::processInputLine(char *line) {
+	// remove trailing whitespace characters
+	int len = strlen(line);
+	if (len > 0)
+		while ((line[len - 1] > 0) && (line[len - 1] <= ' ')) {
+			line[--len] = 0;
+			if (len == 0)
+				break;
+		}
+
+	// number of bytes written in response to the current line;
+	// -1 is used to indicate that the socket has been closed
+	int written = -1;
+
+	if (len == 0) {
+		sprintf(line, "@%d-%s\n", 1, "Empty line.");
+		written = sendMessage(line);
+	}
+	else if (len > Query::MAX_QUERY_LENGTH) {
+		sprintf(line, "@%d-%s\n", 1, "Query too long.");
+		written = sendMessage(line);
+	}
+	else if (strncasecmp(line, "@login ", 7) == 0) {
+		bool result = authenticate(&line[7]);
+		if (result)
+			sprintf(line, "@%d-%s\n", 0, "Authenticated.");
+		else
+			sprintf(line, "@%d-%s\n", 1, "Authentication failed.");
+		written = sendMessage(line);
+	}
+	else if (strcasecmp(line, "@whoami") == 0) {
+		sprintf(line, "%d\n@%d-%s\n", userID, 0, "Ok.");
+		written = sendMessage(line);
+	}
+	else if (strcasecmp(line, "@nofork") == 0) {
+		if ((userID == Index::SUPERUSER) || (userID == geteuid())) {
+			forkOnQuery = false;
+			sprintf(line, "@%d-%s\n", 0, "Fork-on-query disabled.");
+			written = sendMessage(line);
+		}
+		else
+			written = 0;
+	}
+	else if ((strcasecmp(line, "@quit") == 0) || (strcasecmp(line, "@exit") == 0)) {
+		// close connection
+		written = -1;
+	}
+	else {
+		// process the command found in the line just read
+		written = processLine(line);
+	}
+
+	return written;
+} // end of processInputLine(char*)
+
+
 int ClientConnection::processLine(char *line) {
 	snprintf(errorMessage, sizeof(errorMessage), "Line received: %s", line);
 	log(LOG_DEBUG, LOG_ID, errorMessage);
@@ -278,7 +289,15 @@ int ClientConnection::processLine(char *line) {
 	if (queryType == q->QUERY_TYPE_MISC)
 		mustFork = false;
 
-	if ((!mustFork) && (strncasecmp(line, "@getfile ", strlen("@getfile ")) != 0)) {
+	if ((!mustFork) && (strncasecmp(line, "@getfile ", strlen("@getfile ")) != 0) &&
+	    (queryType != q->QUERY_TYPE_UPDATE) && (queryType != q->QUERY_TYPE_MISC) &&
+	    (useQueryThreadPool)) {
+		// ordinary search queries go through the query thread pool, so that the
+		// number of queries processed at the same time is bounded, no matter how
+		// many clients are connected
+		result = QueryExecutor::executeQueryAndWait(q, fd);
+	}
+	else if ((!mustFork) && (strncasecmp(line, "@getfile ", strlen("@getfile ")) != 0)) {
 		// processing an @update or an @misc query can affect the content of the
 		// index; therefore, we have to process the query inside this thread
 		q->parse();
@@ -460,17 +479,8 @@ int ClientConnection::processGetFileQuery(char *line) {
 	sendMessage(message);
 
 	while ((result = forced_read(fd, buffer, sizeof(buffer))) > 0) {
-		int toWrite = result, written = 0;
-		while (toWrite > 0) {
-			result = write(this->fd, &buffer[written], toWrite);
-			if (result < 0)
-				if ((errno != EINTR) && (errno != -EINTR))
-					break;
-			toWrite -= result;
-			written += result;
-		}
-		assert(toWrite >= 0);
-		if (result > 0)
+		written = sendData(buffer, result);
+		if (written > 0)
 			total += written;
 		else
 			break;
@@ -480,9 +490,9 @@ int ClientConnection::processGetFileQuery(char *line) {
 	memset(buffer, 0, sizeof(buffer));
 	while (total < size) {
 		if (total + sizeof(buffer) <= size)
-			written = forced_write(this->fd, buffer, sizeof(buffer));
+			written = sendData(buffer, sizeof(buffer));
 		else
-			written = forced_write(this->fd, buffer, size - total);
+			written = sendData(buffer, size - total);
 		if (written > 0)
 			total += written;
 		else
@@ -495,11 +505,16 @@ int ClientConnection::processGetFileQuery(char *line) {
 
 
 int ClientConnection::sendMessage(const char *message) {
+	return sendData(message, strlen(message));
+} // end of sendMessage(char*)
+
+
+int ClientConnection::sendData(const char *data, int length) {
 	if (fd < 0)
 		return -1;
 	else
-		return forced_write(fd, message, strlen(message));
-} // end of sendMessage(char*)
+		return forced_write(fd, data, length);
+} // end of sendData(char*, int)
 
 
 void ClientConnection::closeSocket() {
@@ -23,7 +23,7 @@
  *
  * author: Stefan Buettcher
  * created: 2004-11-26
- * changed: 2009-02-01
+ * changed: 2026-10-16
  **/
 
 
@@ -60,6 +60,14 @@ protected:
 	 **/
 	bool forkOnQuery;
 
+	/**
+	 * If true (and "forkOnQuery" is false), search queries are handed to the
+	 * QueryExecutor's thread pool, and the connection waits for the result.
+	 * Connections that are already served by a pool worker (EventConnection)
+	 * set this to false and evaluate their queries directly.
+	 **/
+	bool useQueryThreadPool;
+
 	/** Read buffer. Used to received commands from the client. **/
 	char buffer[65536];
 
@@ -92,6 +100,16 @@ public:
 	 **/
 	virtual void run();
 
+	/**
+	 * Takes a complete line received from the client (without the trailing
+	 * newline), handles connection-level commands such as @login and @quit, and
+	 * passes everything else on to processLine. The buffer referenced by "line"
+	 * has to be at least Query::MAX_RESPONSELINE_LENGTH bytes long, as it is
+	 * reused for the response. Returns the number of bytes sent back to the
+	 * client, or -1 if the connection is to be closed.
+	 **/
+	virtual int processInputLine(char *line);
+
 	/**
 	 * Takes a line received from the client, processes it and returns the number
 	 * of bytes sent back to the client in response to the query. If this method
@@ -109,6 +127,12 @@ protected:
 	/** Sends the given message to the client. **/
 	virtual int sendMessage(const char *message);
 
+	/**
+	 * Sends "length" bytes of raw data to the client. Returns the number of
+	 * bytes sent, or -1 if the connection has been closed.
+	 **/
+	virtual int sendData(const char *data, int length);
+
 private:
 
 	/**
@@ -23,7 +23,7 @@
  *
  * author: Stefan Buettcher
  * created: 2004-11-26
- * changed: 2005-11-30
+ * changed: 2026-10-16
  **/
 
 
@@ -38,11 +38,16 @@
 #include <sys/socket.h>
 #include <unistd.h>
 #include "conn_daemon.h"
+#include "event_connection.h"
 #include "multitext_connection.h"
 #include "../misc/all.h"
 #include "../misc/logging.h"
 #include "../misc/configurator.h"
 
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+
 
 const char * ConnDaemon::LOG_ID = "ConnDaemon";
 
@@ -50,15 +55,42 @@ const char * ConnDaemon::LOG_ID = "ConnDaemon";
 ConnDaemon::ConnDaemon(Index *index, int listenPort) {
 	this->index = index;
 	this->listenPort = listenPort;
+
+	// consult configuration file in order to see whether the query protocol
+	// is Wumpus (default) or MultiText
+	char queryProtocol[MAX_CONFIG_VALUE_LENGTH];
+	connectionTypeIsMultiText = false;
+	if (getConfigurationValue("QUERY_PROTOCOL", queryProtocol))
+		if (strcasecmp(queryProtocol, "MultiText") == 0)
+			connectionTypeIsMultiText = true;
+
+	// the event loop cannot be used for MultiText sessions or if queries are
+	// processed by child processes that need exclusive access to the socket
+	bool forkOnQuery;
+	getConfigurationBool("FORK_ON_QUERY", &forkOnQuery, false);
+	getConfigurationBool("TCP_EVENT_LOOP", &useEventLoop, true);
+	if ((connectionTypeIsMultiText) || (forkOnQuery))
+		useEventLoop = false;
+#ifndef __linux__
+	useEventLoop = false;
+#endif
+
 	getConfigurationInt("MAX_TCP_CONNECTIONS", &MAX_TCP_CONNECTIONS, DEFAULT_MAX_TCP_CONNECTIONS);
 	if (MAX_TCP_CONNECTIONS < 0)
 		MAX_TCP_CONNECTIONS = 1;
-	if (MAX_TCP_CONNECTIONS > 32)
-		MAX_TCP_CONNECTIONS = 32;
-	for (int i = 0; i < MAX_TCP_CONNECTIONS; i++)
+	if (useEventLoop) {
+		if (MAX_TCP_CONNECTIONS > MAX_EVENT_LOOP_CONNECTIONS)
+			MAX_TCP_CONNECTIONS = MAX_EVENT_LOOP_CONNECTIONS;
+	}
+	else {
+		if (MAX_TCP_CONNECTIONS > MAX_THREADED_CONNECTIONS)
+			MAX_TCP_CONNECTIONS = MAX_THREADED_CONNECTIONS;
+	}
+	for (int i = 0; i < MAX_THREADED_CONNECTIONS; i++)
 		activeConnections[i] = NULL;
 	activeConnectionCount = 0;
 	listenSocket = -1;
+	epollFD = -1;
 	init();
 	status = STATUS_CREATED;
 } // end of ConnDaemon(Index*, int)
@@ -112,8 +144,9 @@ void ConnDaemon::init() {
 		return;
 	}
 
-	// initialize the listen queue to 4
-	if (listen(listenSocket, 8) < 0) {
+	// initialize the listen queue; with the event loop, we can take a lot more
+	// connections at a time
+	if (listen(listenSocket, useEventLoop ? 128 : 8) < 0) {
 		log(LOG_ERROR, LOG_ID, "TCP Server: Call to listen unsuccessful.");
 		perror(NULL);
 		close(listenSocket);
@@ -175,16 +208,60 @@ void ConnDaemon::killAllActiveConnections() {
 } // end of killAllActiveConnections()
 
 
+bool ConnDaemon::isAllowedAddress(struct sockaddr *connectionAddress) {
+	sockaddr_in *remoteAddress = (sockaddr_in*)connectionAddress;
+	unsigned int sa = ntohl(remoteAddress->sin_addr.s_addr);
+	char address1[32], address2[32];
+	sprintf(address1, "%d.%d.%d.%d",
+			sa / (65536 * 256), (sa / 65536) % 256, (sa / 256) % 256, sa % 256);
+	sprintf(address2, "%03d.%03d.%03d.%03d",
+			sa / (65536 * 256), (sa / 65536) % 256, (sa / 256) % 256, sa % 256);
+	bool acceptConnection = false;
+	char **allowed = getConfigurationArray("TCP_ALLOWED");
+	if (allowed != NULL) {
+		for (int i = 0; allowed[i] != NULL; i++) {
+			if ((matchesPattern(address1, allowed[i])) || (matchesPattern(address2, allowed[i])))
+				acceptConnection = true;
+			free(allowed[i]);
+		}
+		free(allowed);
+	}
+	return acceptConnection;
+} // end of isAllowedAddress(sockaddr*)
+
+
+uid_t ConnDaemon::getInitialUserID(struct sockaddr *connectionAddress) {
+	sockaddr_in *remoteAddress = (sockaddr_in*)connectionAddress;
+	int remotePort = ntohs(remoteAddress->sin_port);
+	if (connectionTypeIsMultiText)
+		return Index::NOBODY;
+	else if (remotePort < 1024) {
+		// only root can do this; so, we assume we are dealing with root here
+		return 0;
+	}
+	else {
+		// open a standard session with default user NOBODY
+		return Index::NOBODY;
+	}
+} // end of getInitialUserID(sockaddr*)
+
+
 void ConnDaemon::run() {
-	char buffer[256];
+	if (useEventLoop)
+		runEventLoop();
+	else
+		runThreaded();
+	if (getLock()) {
+		status = STATUS_TERMINATED;
+		releaseLock();
+	}
+	else
+		status = STATUS_TERMINATED;
+} // end of run()
 
-	// consult configuration file in order to see whether the query protocol
-	// is Wumpus (default) or MultiText
-	char queryProtocol[MAX_CONFIG_VALUE_LENGTH];
-	bool connectionTypeIsMultiText = false;
-	if (getConfigurationValue("QUERY_PROTOCOL", queryProtocol))
-		if (strcasecmp(queryProtocol, "MultiText") == 0)
-			connectionTypeIsMultiText = true;
+
+void ConnDaemon::runThreaded() {
+	char buffer[256];
 
 	while (!stopRequested()) {
 		struct sockaddr connectionAddress;
@@ -201,39 +278,16 @@ void ConnDaemon::run() {
 		else {
 			int one = 1;
 			setsockopt(clientConnection, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(int));
-			sockaddr_in *remoteAddress = (sockaddr_in*)&connectionAddress;
-			int remotePort = ntohs(remoteAddress->sin_port);
-			unsigned int sa = ntohl(remoteAddress->sin_addr.s_addr);
-			char address1[32], address2[32];
-			sprintf(address1, "%d.%d.%d.%d",
-					sa / (65536 * 256), (sa / 65536) % 256, (sa / 256) % 256, sa % 256);
-			sprintf(address2, "%03d.%03d.%03d.%03d",
-					sa / (65536 * 256), (sa / 65536) % 256, (sa / 256) % 256, sa % 256);
-			bool acceptConnection = false;
-			char **allowed = getConfigurationArray("TCP_ALLOWED");
-			if (allowed != NULL) {
-				for (int i = 0; allowed[i] != NULL; i++) {
-					if ((matchesPattern(address1, allowed[i])) || (matchesPattern(address2, allowed[i])))
-						acceptConnection = true;
-					free(allowed[i]);
-				}
-				free(allowed);
-			}
-			if (acceptConnection) {
+			if (isAllowedAddress(&connectionAddress)) {
 				ClientConnection *cc;
+				uid_t userID = getInitialUserID(&connectionAddress);
 
 				if (connectionTypeIsMultiText) {
 					// open a MultiText session (for backwards compatibility)
-					cc = new MultiTextConnection(index, clientConnection, Index::NOBODY);
-				}
-				else if (remotePort < 1024) {
-					// only root can do this; so, we assume we are dealing with root here
-					cc = new ClientConnection(index, clientConnection, 0);
-				}
-				else {
-					// open a standard session with default user NOBODY
-					cc = new ClientConnection(index, clientConnection, Index::NOBODY);
+					cc = new MultiTextConnection(index, clientConnection, userID);
 				}
+				else
+					cc = new ClientConnection(index, clientConnection, userID);
 
 				if (!addActiveConnection(cc)) {
 					strcpy(buffer, "@1-Too many open sessions.\n");
@@ -258,12 +312,105 @@ void ConnDaemon::run() {
 	}
 	close(listenSocket);
 	killAllActiveConnections();
-	if (getLock()) {
-		status = STATUS_TERMINATED;
-		releaseLock();
+} // end of runThreaded()
+
+
+void ConnDaemon::runEventLoop() {
+#ifdef __linux__
+	epollFD = epoll_create(MAX_EVENTS_PER_WAIT);
+	if (epollFD < 0) {
+		log(LOG_ERROR, LOG_ID, "Unable to create epoll instance. Falling back to threads.");
+		useEventLoop = false;
+		if (MAX_TCP_CONNECTIONS > MAX_THREADED_CONNECTIONS)
+			MAX_TCP_CONNECTIONS = MAX_THREADED_CONNECTIONS;
+		runThreaded();
+		return;
 	}
-	else
-		status = STATUS_TERMINATED;
-} // end of run()
+
+	// the listen socket is registered with a NULL pointer, so we can tell it
+	// apart from the client connections
+	fcntl(listenSocket, F_SETFL, fcntl(listenSocket, F_GETFL) | O_NONBLOCK);
+	struct epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.ptr = NULL;
+	epoll_ctl(epollFD, EPOLL_CTL_ADD, listenSocket, &event);
+
+	struct epoll_event events[MAX_EVENTS_PER_WAIT];
+	while (!stopRequested()) {
+		// the timeout is only needed to check for stop requests every once in a
+		// while; the destructor wakes us up by connecting to the listen socket
+		int eventCount = epoll_wait(epollFD, events, MAX_EVENTS_PER_WAIT, 1000);
+		if (stopRequested())
+			break;
+		for (int i = 0; i < eventCount; i++) {
+			EventConnection *conn = (EventConnection*)events[i].data.ptr;
+			if (conn == NULL) {
+				acceptEventConnections();
+				continue;
+			}
+			if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+				closeEventConnection(conn);
+				continue;
+			}
+			bool ok = true;
+			if (events[i].events & (EPOLLIN | EPOLLRDHUP))
+				ok = conn->readInput();
+			if ((ok) && (events[i].events & EPOLLOUT))
+				ok = conn->flushOutput();
+			if ((!ok) || (conn->mustClose()))
+				closeEventConnection(conn);
+		}
+	}
+
+	close(listenSocket);
+	while (!eventConnections.empty())
+		closeEventConnection(*eventConnections.begin());
+	close(epollFD);
+	epollFD = -1;
+#endif
+} // end of runEventLoop()
+
+
+void ConnDaemon::acceptEventConnections() {
+	static const char *connectedMessage = "@0-Connected.\n";
+	static const char *tooManyMessage = "@1-Too many open sessions.\n";
+	while (true) {
+		struct sockaddr connectionAddress;
+		socklen_t addressLength = sizeof(sockaddr);
+		int clientConnection = accept(listenSocket, &connectionAddress, &addressLength);
+		if (clientConnection < 0)
+			break;
+		if (!isAllowedAddress(&connectionAddress)) {
+			// if the remote host is not localhost, then we refuse to talk to him
+			close(clientConnection);
+			continue;
+		}
+		if (eventConnections.size() >= MAX_TCP_CONNECTIONS) {
+			send(clientConnection, tooManyMessage, strlen(tooManyMessage), MSG_NOSIGNAL | MSG_DONTWAIT);
+			shutdown(clientConnection, SHUT_RDWR);
+			close(clientConnection);
+			continue;
+		}
+
+		// disable Nagle's algorithm in order to decrease communication latency
+		int one = 1;
+		setsockopt(clientConnection, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(int));
+		fcntl(clientConnection, F_SETFL, fcntl(clientConnection, F_GETFL) | O_NONBLOCK);
+
+		EventConnection *conn = new EventConnection(
+				index, clientConnection, getInitialUserID(&connectionAddress), epollFD);
+		eventConnections.insert(conn);
+		if (conn->sendMessage(connectedMessage) < 0)
+			closeEventConnection(conn);
+	}
+} // end of acceptEventConnections()
+
+
+void ConnDaemon::closeEventConnection(EventConnection *conn) {
+	eventConnections.erase(conn);
+	if (conn->closeConnection())
+		delete conn;
+} // end of closeEventConnection(EventConnection*)
 
 
@@ -22,9 +22,15 @@
  * The ConnDaemon class is responsible for TCP connections to the index server.
  * TCP connections can be used for unauthenticated queries (UID == NOBODY).
  *
+ * On Linux, all connections are served by a single epoll event loop running
+ * in the ConnDaemon's thread (see EventConnection), and queries are processed
+ * by the QueryExecutor's thread pool. If TCP_EVENT_LOOP is disabled, or if
+ * the configuration asks for MultiText protocol or FORK_ON_QUERY, every
+ * connection gets its own ClientConnection thread instead.
+ *
  * author: Stefan Buettcher
  * created: 2004-10-08
- * changed: 2009-02-01
+ * changed: 2026-10-16
  **/
 
 
@@ -39,9 +45,11 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <set>
 
 
 class ClientConnection;
+class EventConnection;
 
 
 class ConnDaemon : public Daemon {
@@ -50,6 +58,16 @@ public:
 
 	static const int DEFAULT_MAX_TCP_CONNECTIONS = 4;
 
+	/**
+	 * Upper limit for MAX_TCP_CONNECTIONS. Connections served by a thread of
+	 * their own are limited to 32.
+	 **/
+	static const int MAX_EVENT_LOOP_CONNECTIONS = 65536;
+	static const int MAX_THREADED_CONNECTIONS = 32;
+
+	/** Maximum number of events processed per call to epoll_wait. **/
+	static const int MAX_EVENTS_PER_WAIT = 256;
+
 	/** "ConnDaemon". **/
 	static const char *LOG_ID;
 
@@ -63,10 +81,22 @@ private:
 
 	int MAX_TCP_CONNECTIONS;
 
-	ClientConnection *activeConnections[32];
+	ClientConnection *activeConnections[MAX_THREADED_CONNECTIONS];
 
 	int activeConnectionCount;
 
+	/** True if connections are served by the epoll event loop. **/
+	bool useEventLoop;
+
+	/** True if clients talk to us using the MultiText protocol. **/
+	bool connectionTypeIsMultiText;
+
+	/** The epoll instance used by the event loop. **/
+	int epollFD;
+
+	/** All connections currently served by the event loop. **/
+	std::set<EventConnection*> eventConnections;
+
 public:
 
 	/** Creates a new daemon listening on port "listenPort". **/
@@ -91,6 +121,30 @@ private:
 
 	void executeQuery(int tcpConnection, char *queryString);
 
+	/**
+	 * Checks whether the given remote address matches one of the TCP_ALLOWED
+	 * patterns from the configuration file.
+	 **/
+	bool isAllowedAddress(struct sockaddr *connectionAddress);
+
+	/** Returns the initial user ID for a new connection from the given address. **/
+	uid_t getInitialUserID(struct sockaddr *connectionAddress);
+
+	/** Accept loop used when every connection has its own thread. **/
+	void runThreaded();
+
+	/** Accept/read/write loop used when all connections share one epoll instance. **/
+	void runEventLoop();
+
+	/** Accepts all pending connections on the (non-blocking) listen socket. **/
+	void acceptEventConnections();
+
+	/**
+	 * Closes the given connection and forgets about it. The object is deleted
+	 * once no worker thread is using it any more.
+	 **/
+	void closeEventConnection(EventConnection *conn);
+
 }; // end of class ConnDaemon
 
 
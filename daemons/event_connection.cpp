@@ -0,0 +1,328 @@
+/**
+ * Copyright (C) 2007 Stefan Buettcher. All rights reserved.
+ * This is free software with ABSOLUTELY NO WARRANTY.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA
+ **/
+/**
+ * Implementation of the EventConnection class.
+ *
+ * author: Stefan Buettcher
+ * created: 2026-10-16
+ * changed: 2026-10-16
+ **/
+
+
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "event_connection.h"
+#include "query_executor.h"
+#include "../misc/all.h"
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+
+
+static const char *LOG_ID = "EventConnection";
+
+
+EventConnection::EventConnection(Index *index, int fd, uid_t userID, int epollFD) {
+	initialize(index, fd, userID);
+
+	// we are already running inside a worker thread when processing a query;
+	// forking would interfere with the event loop reading from the socket
+	forkOnQuery = false;
+	useQueryThreadPool = false;
+
+	this->epollFD = epollFD;
+	outputStart = 0;
+	busy = false;
+	closed = false;
+	inputClosed = false;
+	readingSuspended = false;
+	closeWhenFlushed = false;
+	currentLine = NULL;
+	writerWaiting = false;
+	SEM_INIT(outputDrained, 0);
+	bufferSize = 0;
+	buffer[0] = 0;
+
+#ifdef __linux__
+	struct epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN | EPOLLRDHUP;
+	event.data.ptr = this;
+	if (epoll_ctl(epollFD, EPOLL_CTL_ADD, fd, &event) != 0) {
+		log(LOG_ERROR, LOG_ID, "Unable to register socket with epoll.");
+		closed = true;
+	}
+#endif
+} // end of EventConnection(Index*, int, uid_t, int)
+
+
+EventConnection::~EventConnection() {
+	if (currentLine != NULL)
+		free(currentLine);
+	sem_destroy(&outputDrained);
+} // end of ~EventConnection()
+
+
+void EventConnection::run() {
+	assert("EventConnection::run() must not be called" == NULL);
+} // end of run()
+
+
+void EventConnection::updateEvents() {
+#ifdef __linux__
+	if (closed)
+		return;
+	struct epoll_event event;
+	memset(&event, 0, sizeof(event));
+	if ((!readingSuspended) && (!inputClosed))
+		event.events |= EPOLLIN | EPOLLRDHUP;
+	if ((output.length() > outputStart) || (closeWhenFlushed))
+		event.events |= EPOLLOUT;
+	event.data.ptr = this;
+	epoll_ctl(epollFD, EPOLL_CTL_MOD, fd, &event);
+#endif
+} // end of updateEvents()
+
+
+bool EventConnection::writePendingOutput() {
+	while (output.length() > outputStart) {
+		int result = send(fd, &output.data()[outputStart],
+				output.length() - outputStart, MSG_NOSIGNAL | MSG_DONTWAIT);
+		if (result > 0)
+			outputStart += result;
+		else if ((result < 0) && (errno == EINTR))
+			continue;
+		else if ((result < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+			break;
+		else
+			return false;
+	}
+	if (outputStart >= output.length()) {
+		output.clear();
+		outputStart = 0;
+	}
+	else if (outputStart >= MAX_PENDING_OUTPUT) {
+		output.erase(0, outputStart);
+		outputStart = 0;
+	}
+	if ((writerWaiting) && (output.length() - outputStart <= MAX_PENDING_OUTPUT / 2)) {
+		writerWaiting = false;
+		sem_post(&outputDrained);
+	}
+	return true;
+} // end of writePendingOutput()
+
+
+int EventConnection::sendData(const char *data, int length) {
+	getLock();
+	if (closed) {
+		releaseLock();
+		return -1;
+	}
+	output.append(data, length);
+	if (!writePendingOutput()) {
+		releaseLock();
+		return -1;
+	}
+	updateEvents();
+
+	// if the client does not keep up with us, wait until it does
+	while ((output.length() - outputStart > MAX_PENDING_OUTPUT) && (!closed)) {
+		writerWaiting = true;
+		releaseLock();
+		sem_wait(&outputDrained);
+		getLock();
+	}
+	int result = (closed ? -1 : length);
+	releaseLock();
+	return result;
+} // end of sendData(char*, int)
+
+
+bool EventConnection::readInput() {
+	LocalLock lock(this);
+	if ((closed) || (inputClosed))
+		return !closed;
+	while (true) {
+		if (bufferSize >= sizeof(buffer) - 2) {
+			// buffer full; stop reading until the worker has taken a line
+			readingSuspended = true;
+			break;
+		}
+		int result = read(fd, &buffer[bufferSize], sizeof(buffer) - 2 - bufferSize);
+		if (result > 0)
+			bufferSize += result;
+		else if (result == 0) {
+			inputClosed = true;
+			break;
+		}
+		else if (errno == EINTR)
+			continue;
+		else if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+			break;
+		else
+			return false;
+	}
+	buffer[bufferSize] = 0;
+	dispatchNextLine();
+	updateEvents();
+	return true;
+} // end of readInput()
+
+
+bool EventConnection::flushOutput() {
+	LocalLock lock(this);
+	if (closed)
+		return false;
+	if (!writePendingOutput())
+		return false;
+	updateEvents();
+	return true;
+} // end of flushOutput()
+
+
+bool EventConnection::mustClose() {
+	LocalLock lock(this);
+	return ((closeWhenFlushed) && (!busy) && (output.length() <= outputStart));
+} // end of mustClose()
+
+
+bool EventConnection::closeConnection() {
+	LocalLock lock(this);
+	if (!closed) {
+#ifdef __linux__
+		epoll_ctl(epollFD, EPOLL_CTL_DEL, fd, NULL);
+#endif
+		shutdown(fd, SHUT_RDWR);
+		close(fd);
+		closed = true;
+	}
+	if (writerWaiting) {
+		writerWaiting = false;
+		sem_post(&outputDrained);
+	}
+	return !busy;
+} // end of closeConnection()
+
+
+void EventConnection::closeSocket() {
+	// the socket is owned by the ConnDaemon's event loop; just make sure the
+	// client is not served any more and let the event loop clean up
+	LocalLock lock(this);
+	inputClosed = true;
+	closeWhenFlushed = true;
+	if (!closed)
+		shutdown(fd, SHUT_RDWR);
+} // end of closeSocket()
+
+
+void EventConnection::dispatchNextLine() {
+	while ((!busy) && (!closed) && (!closeWhenFlushed)) {
+		// same rules as in ClientConnection::run(): if no EOL has been seen and the
+		// buffer is getting too full, pretend we have seen one
+		char *newLine = strchr(buffer, '\n');
+		if (newLine == NULL) {
+			if ((bufferSize >= sizeof(buffer) / 4) || ((inputClosed) && (bufferSize > 0))) {
+				buffer[bufferSize++] = '\n';
+				buffer[bufferSize] = 0;
+				newLine = &buffer[bufferSize - 1];
+			}
+			else {
+				if (inputClosed) {
+					// nothing more to come from the client: close after last response
+					closeWhenFlushed = true;
+				}
+				return;
+			}
+		}
+		*newLine = 0;
+		newLine++;
+		currentLine = duplicateString(buffer);
+		bufferSize -= ((long)newLine) - ((long)buffer);
+		memmove(buffer, newLine, bufferSize);
+		buffer[bufferSize] = 0;
+		if (readingSuspended) {
+			readingSuspended = false;
+			updateEvents();
+		}
+
+		busy = true;
+		if (QueryExecutor::submit(processLineTask, this))
+			return;
+
+		// the query queue is full: reject this line and move on to the next one
+		busy = false;
+		free(currentLine);
+		currentLine = NULL;
+		static const char *busyMessage = "@1-Server busy.\n";
+		output.append(busyMessage, strlen(busyMessage));
+		if (!writePendingOutput())
+			closeWhenFlushed = true;
+		updateEvents();
+	}
+} // end of dispatchNextLine()
+
+
+void EventConnection::processLineTask(void *data, bool expired) {
+	EventConnection *conn = (EventConnection*)data;
+	char line[Query::MAX_RESPONSELINE_LENGTH];
+
+	conn->getLock();
+	strcpy(line, conn->currentLine);
+	free(conn->currentLine);
+	conn->currentLine = NULL;
+	conn->releaseLock();
+
+	int written;
+	if (expired) {
+		sprintf(line, "@%d-%s\n", Query::STATUS_ERROR, "Query timed out in queue.");
+		written = conn->sendMessage(line);
+	}
+	else
+		written = conn->processInputLine(line);
+
+	conn->getLock();
+	conn->busy = false;
+	if (conn->closed) {
+		// the event loop has already given up on this connection
+		conn->releaseLock();
+		delete conn;
+		return;
+	}
+	if (written < 0) {
+		// @quit or broken connection
+		conn->inputClosed = true;
+		conn->closeWhenFlushed = true;
+	}
+	else
+		conn->dispatchNextLine();
+	conn->updateEvents();
+	conn->releaseLock();
+} // end of processLineTask(void*, bool)
+
+
+void EventConnection::getClassName(char *target) {
+	strcpy(target, "EventConnection");
+}
+
+
@@ -0,0 +1,170 @@
+/**
+ * Copyright (C) 2007 Stefan Buettcher. All rights reserved.
+ * This is free software with ABSOLUTELY NO WARRANTY.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA
+ **/
+/**
+ * EventConnection is the kind of ClientConnection used when the ConnDaemon
+ * runs its epoll event loop. It does not have a thread of its own. The
+ * ConnDaemon reads data from the socket whenever epoll tells it to; complete
+ * lines are handed to the QueryExecutor's thread pool, one line at a time, so
+ * that the responses are sent back in the order in which the queries were
+ * received. Output produced by the worker thread is written to the socket
+ * directly if possible; everything that does not fit into the socket buffer
+ * is queued and sent by the ConnDaemon when the socket becomes writable.
+ *
+ * author: Stefan Buettcher
+ * created: 2026-10-16
+ * changed: 2026-10-16
+ **/
+
+
+#ifndef __DAEMONS__EVENT_CONNECTION_H
+#define __DAEMONS__EVENT_CONNECTION_H
+
+
+#include <semaphore.h>
+#include <string>
+#include "client_connection.h"
+
+
+class EventConnection : public ClientConnection {
+
+	friend class ConnDaemon;
+
+public:
+
+	/**
+	 * If more than this many bytes are waiting to be sent to the client, the
+	 * worker thread producing the output is suspended until the client has
+	 * caught up.
+	 **/
+	static const int MAX_PENDING_OUTPUT = 1024 * 1024;
+
+private:
+
+	/** The epoll instance that the socket is registered with. **/
+	int epollFD;
+
+	/** Data waiting to be sent to the client, starting at "outputStart". **/
+	std::string output;
+	int outputStart;
+
+	/** True while a worker thread is processing a line from this connection. **/
+	bool busy;
+
+	/** Set by the ConnDaemon after the socket has been closed. **/
+	bool closed;
+
+	/** True if the client will not send any more data (EOF or @quit). **/
+	bool inputClosed;
+
+	/** True if the input buffer is full and we stopped reading from the socket. **/
+	bool readingSuspended;
+
+	/**
+	 * Tells the ConnDaemon to close the connection as soon as all pending
+	 * output has been sent.
+	 **/
+	bool closeWhenFlushed;
+
+	/** Line currently processed by the worker thread. **/
+	char *currentLine;
+
+	/** Used to wake up a worker thread waiting for output space. **/
+	sem_t outputDrained;
+	bool writerWaiting;
+
+public:
+
+	/**
+	 * Creates a new connection for the given non-blocking socket and registers
+	 * it with the epoll instance "epollFD".
+	 **/
+	EventConnection(Index *index, int fd, uid_t userID, int epollFD);
+
+	virtual ~EventConnection();
+
+	/**
+	 * Called by the ConnDaemon when data are available. Reads everything that
+	 * is there and dispatches the next complete line, unless another line is
+	 * still being processed. Returns false if the connection is broken.
+	 **/
+	bool readInput();
+
+	/**
+	 * Called by the ConnDaemon when the socket is writable. Sends as much of
+	 * the pending output as possible. Returns false if the connection is broken.
+	 **/
+	bool flushOutput();
+
+	/**
+	 * Returns true if the connection has nothing left to do and should be
+	 * closed by the ConnDaemon.
+	 **/
+	bool mustClose();
+
+	/**
+	 * Closes the socket and removes it from the epoll instance. Returns true if
+	 * the object can be deleted right away. Otherwise, a worker thread is still
+	 * busy with it and will delete it when done.
+	 **/
+	bool closeConnection();
+
+	/** Does not apply to event-driven connections. **/
+	virtual void run();
+
+	virtual void closeSocket();
+
+	virtual void getClassName(char *target);
+
+protected:
+
+	/**
+	 * Sends the data to the client, without blocking on the socket. If the
+	 * client is too slow, the caller is suspended until there is room in
+	 * the output queue again.
+	 **/
+	virtual int sendData(const char *data, int length);
+
+private:
+
+	/**
+	 * If no line is being processed right now, takes the next complete line
+	 * from the input buffer and hands it to the query thread pool. Must be
+	 * called with the lock held.
+	 **/
+	void dispatchNextLine();
+
+	/** Tells epoll which events we are interested in. Lock must be held. **/
+	void updateEvents();
+
+	/**
+	 * Writes as much pending output as the socket takes. Lock must be held.
+	 * Returns false on error.
+	 **/
+	bool writePendingOutput();
+
+	/** Task function executed by the worker threads. **/
+	static void processLineTask(void *data, bool expired);
+
+}; // end of class EventConnection
+
+
+#endif
+
+
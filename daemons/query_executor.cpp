@@ -23,7 +23,7 @@
  *
  * author: Stefan Buettcher
  * created: 2005-03-14
- * changed: 2009-02-01
+ * changed: 2026-10-16
  **/
 
 
@@ -35,9 +35,19 @@
 #include "../misc/all.h"
 
 
-static void pushString(const char *string, int fd) {
+static const char * LOG_ID = "QueryExecutor";
+
+static ThreadPool *queryThreadPool = NULL;
+
+static pthread_once_t queryThreadPoolOnce = PTHREAD_ONCE_INIT;
+
+/** Maximum time (in ms) a query may wait in the queue; 0 means no limit. **/
+static int queryDeadline = QueryExecutor::DEFAULT_DEADLINE;
+
+
+static int pushString(const char *string, int fd) {
 	if (fd < 0)
-		return;
+		return 0;
 	int len = strlen(string);
 	int written = 0;
 	int cnt = 0;
@@ -45,44 +55,113 @@ static void pushString(const char *string, int fd) {
 		int result = write(fd, &string[written], len - written);
 		if (result < 0) {
 			if (errno != -EINTR)
-				break;
+				return -1;
 			else if (++cnt > 3)
-				break;
+				return -1;
 		}
 		else
 			written += result;
 	}
+	return written;
 } // end of pushString(char*, int)
 
 
-static void *executionFunction(void *data) {
+static void executionFunction(void *data, bool expired) {
 	char resultLine[Query::MAX_RESPONSELINE_LENGTH];
 	QuerySessionDescriptor *qsd = (QuerySessionDescriptor*)data;
-	if (qsd->query->parse()) {
-		while (qsd->query->getNextLine(resultLine)) {
-			pushString(resultLine, qsd->outputFD);
-			pushString("\n", qsd->outputFD);
+	if (expired) {
+		// the query has been waiting for too long; do not even start it
+		sprintf(resultLine, "@%d-%s\n", Query::STATUS_ERROR, "Query timed out in queue.");
+		pushString(resultLine, qsd->outputFD);
+		qsd->result = -1;
+	}
+	else {
+		if (qsd->query->parse()) {
+			while (qsd->query->getNextLine(resultLine)) {
+				if (pushString(resultLine, qsd->outputFD) < 0)
+					qsd->result = -1;
+				pushString("\n", qsd->outputFD);
+			}
 		}
+		int statusCode;
+		char statusLine[1024];
+		qsd->query->getStatus(&statusCode, statusLine);
+		sprintf(resultLine, "@%d-%s\n", statusCode, statusLine);
+		if (pushString(resultLine, qsd->outputFD) < 0)
+			qsd->result = -1;
+	}
+	if (qsd->finished != NULL) {
+		// executeQueryAndWait takes care of the rest
+		sem_post(qsd->finished);
+		return;
 	}
-	int statusCode;
-	char statusLine[1024];
-	qsd->query->getStatus(&statusCode, statusLine);
-	sprintf(resultLine, "@%d-%s\n", statusCode, statusLine);
-	pushString(resultLine, qsd->outputFD);
 	delete qsd->query;
 	QueryExecutor::shutdownAndClose(qsd->outputFD);
 	free(qsd);
-} // end of executionFunction(void*)
+} // end of executionFunction(void*, bool)
+
+
+static void createQueryThreadPool() {
+	int workerCount = QueryExecutor::DEFAULT_WORKER_THREADS;
+	int queueLength = QueryExecutor::DEFAULT_QUEUE_LENGTH;
+	getConfigurationInt("QUERY_WORKER_THREADS", &workerCount, QueryExecutor::DEFAULT_WORKER_THREADS);
+	getConfigurationInt("QUERY_QUEUE_LENGTH", &queueLength, QueryExecutor::DEFAULT_QUEUE_LENGTH);
+	getConfigurationInt("QUERY_DEADLINE", &queryDeadline, QueryExecutor::DEFAULT_DEADLINE);
+	if (queryDeadline < 0)
+		queryDeadline = 0;
+	queryThreadPool = new ThreadPool("query", workerCount, queueLength);
+} // end of createQueryThreadPool()
+
+
+ThreadPool * QueryExecutor::getThreadPool() {
+	pthread_once(&queryThreadPoolOnce, createQueryThreadPool);
+	return queryThreadPool;
+} // end of getThreadPool()
+
+
+bool QueryExecutor::submit(ThreadPoolTask task, void *data) {
+	return getThreadPool()->submit(task, data, queryDeadline);
+} // end of submit(ThreadPoolTask, void*)
 
 
 void QueryExecutor::executeQuery(Query *query, int outputFD) {
-	pthread_t threadID;
 	QuerySessionDescriptor *qsd = typed_malloc(QuerySessionDescriptor, 1);
 	qsd->query = query;
 	qsd->outputFD = outputFD;
-	pthread_create(&threadID, NULL, executionFunction, qsd);
-	pthread_detach(threadID);
-} // end of executeQuery(char*, int)
+	qsd->finished = NULL;
+	qsd->result = 0;
+	if (!getThreadPool()->submit(executionFunction, qsd, queryDeadline)) {
+		log(LOG_DEBUG, LOG_ID, "Query rejected: queue full.");
+		char message[64];
+		sprintf(message, "@%d-%s\n", Query::STATUS_ERROR, "Server busy.");
+		pushString(message, outputFD);
+		delete query;
+		shutdownAndClose(outputFD);
+		free(qsd);
+	}
+} // end of executeQuery(Query*, int)
+
+
+int QueryExecutor::executeQueryAndWait(Query *query, int outputFD) {
+	sem_t finished;
+	QuerySessionDescriptor qsd;
+	qsd.query = query;
+	qsd.outputFD = outputFD;
+	qsd.finished = &finished;
+	qsd.result = 0;
+	sem_init(&finished, 0, 0);
+	if (getThreadPool()->submit(executionFunction, &qsd, queryDeadline))
+		sem_wait(&finished);
+	else {
+		log(LOG_DEBUG, LOG_ID, "Query rejected: queue full.");
+		char message[64];
+		sprintf(message, "@%d-%s\n", Query::STATUS_ERROR, "Server busy.");
+		if (pushString(message, outputFD) < 0)
+			qsd.result = -1;
+	}
+	sem_destroy(&finished);
+	return (qsd.result < 0 ? -1 : 1);
+} // end of executeQueryAndWait(Query*, int)
 
 
 void QueryExecutor::shutdownAndClose(int fd) {
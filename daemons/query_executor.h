@@ -20,11 +20,15 @@
 
 /**
  * Definition of the QueryExecutor class. QueryExecutor is used to process
- * queries in parallel. For each incoming query, a new thread is spawned.
+ * queries in parallel. Incoming queries are handed to a fixed-size pool of
+ * worker threads (see ThreadPool). The size of the pool, the maximum number
+ * of waiting queries, and the time a query may spend waiting before it is
+ * dropped are taken from the configuration file (QUERY_WORKER_THREADS,
+ * QUERY_QUEUE_LENGTH, QUERY_DEADLINE).
  *
  * author: Stefan Buettcher
  * created: 2005-03-14
- * changed: 2009-02-01
+ * changed: 2026-10-16
  **/
 
 
@@ -32,6 +36,8 @@
 #define __DAEMONS__QUERY_EXECUTOR_H
 
 
+#include <semaphore.h>
+#include "../misc/thread_pool.h"
 #include "../query/query.h"
 
 
@@ -41,6 +47,15 @@ typedef struct {
 
 	int outputFD;
 
+	/**
+	 * If non-NULL, the worker does not close "outputFD" when it is done, but
+	 * posts to this semaphore instead (used by executeQueryAndWait).
+	 **/
+	sem_t *finished;
+
+	/** Set to -1 if the query could not be run or the output could not be sent. **/
+	int result;
+
 } QuerySessionDescriptor;
 
 
@@ -48,16 +63,42 @@ class QueryExecutor {
 
 public:
 
+	/** Default values for the configuration variables. **/
+	static const int DEFAULT_WORKER_THREADS = 8;
+	static const int DEFAULT_QUEUE_LENGTH = 256;
+	static const int DEFAULT_DEADLINE = 0;
+
 	/**
-	 * Creates a new thread that processes the query given by "queryString". The
-	 * results of the query will be written to "outputFD". After the query execution
-	 * has finished, "outputFD" will be shutdown and closed (unless it is one of
-	 * stdin, stdout, stderr).
+	 * Hands the query to the query thread pool. The results of the query will
+	 * be written to "outputFD". After the query execution has finished,
+	 * "outputFD" will be shutdown and closed (unless it is one of stdin,
+	 * stdout, stderr). If the pool's queue is full or the query's deadline
+	 * passes before a worker picks it up, an error status line is sent instead.
 	 * The Query instance will automatically be taken care of, and all memory will
 	 * be released once the query has been processed.
 	 **/
 	static void executeQuery(Query *query, int outputFD);
 
+	/**
+	 * Same as above, but blocks until the query has been processed and leaves
+	 * "outputFD" open. The Query instance is not deleted. Returns a negative
+	 * value if the query was not run or the results could not be sent.
+	 **/
+	static int executeQueryAndWait(Query *query, int outputFD);
+
+	/**
+	 * Returns the thread pool used to process queries, creating it if
+	 * necessary.
+	 **/
+	static ThreadPool *getThreadPool();
+
+	/**
+	 * Submits a job to the query thread pool, subject to the same queue limit
+	 * and QUERY_DEADLINE as queries sent through executeQuery. Returns false if
+	 * the queue is full.
+	 **/
+	static bool submit(ThreadPoolTask task, void *data);
+
 	/**
 	 * Calls shutdown and close for "fd" (unless it is stdin, stdout, or stderr).
 	 **/
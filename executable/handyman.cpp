@@ -43,6 +43,7 @@
 #include "../feedback/language_model.h"
 #include "../filters/trec_inputstream.h"
 #include "../index/compactindex2.h"
+#include "../index/index_compression_simd.h"
 #include "../index/index_iterator.h"
 #include "../index/index_merger.h"
 #include "../index/multiple_index_iterator.h"
@@ -111,6 +112,9 @@ void usage() {
 	fprintf(stderr, "- MEASURE_DECODING_PERFORMANCE Takes an inverted file and a compression method.\n");
 	fprintf(stderr, "                  Reads a sequence of terms from stdin and measures the decoding\n");
 	fprintf(stderr, "                  performance of the given method on the given postings lists.\n");
+	fprintf(stderr, "- MEASURE_SIMD_DECODING  Compares the decoding performance of the scalar and\n");
+	fprintf(stderr, "                  the SIMD decoders for vByte and GroupVarInt, using synthetic\n");
+	fprintf(stderr, "                  postings lists with different average gap sizes.\n");
 	fprintf(stderr, "- MERGE_INDICES   Takes a list of input index files followed by the file name\n");
 	fprintf(stderr, "                  of the output index. Merges the input files into the target.\n");
 	fprintf(stderr, "- RECOMPRESS_INDEX  Takes three parameters: input index, output index, and\n");
@@ -1753,6 +1757,68 @@ static void measureDecodingPerformance(int argc, char **argv) {
 } // end of measureDecodingPerformance(int, char**)
 
 
+static void measureSIMDDecoding(int argc, char **argv) {
+	if (argc != 0) {
+		fprintf(stderr, "Usage:  MEASURE_SIMD_DECODING\n");
+		exit(0);
+	}
+
+	static const int LIST_LENGTH = 32 * 1024;
+	static const double MIN_TIME_PER_MEASUREMENT = 0.2;
+	static const int METHODS[2] = { COMPRESSION_VBYTE, COMPRESSION_GROUPVARINT };
+	const int bestLevel = getSIMDDecodingLevel();
+	offset *list = typed_malloc(offset, LIST_LENGTH);
+	offset *output = typed_malloc(offset, LIST_LENGTH + 1);
+
+	printf("Method         Avg. gap      Bits/posting");
+	for (int level = SIMD_DECODING_NONE; level <= bestLevel; level++)
+		printf("  %10s", getSIMDDecodingLevelName(level));
+	printf("     Speedup\n");
+	printf("------------------------------------------");
+	for (int level = SIMD_DECODING_NONE; level <= bestLevel; level++)
+		printf("------------");
+	printf("------------\n");
+
+	for (int m = 0; m < 2; m++) {
+		for (int avgGap = 2; avgGap <= (1 << 20); avgGap *= 4) {
+			offset prev = 0;
+			for (int i = 0; i < LIST_LENGTH; i++) {
+				prev += random() % (avgGap * 2 - 1) + 1;
+				list[i] = prev;
+			}
+			int byteLength, listLength;
+			byte *compressed = compressorForID[METHODS[m]](list, LIST_LENGTH, &byteLength);
+			printf("%-12s %10d %17.2lf", (m == 0 ? "vByte" : "GroupVarInt"),
+					avgGap, byteLength * 8.0 / LIST_LENGTH);
+
+			double nsPerPosting[SIMD_DECODING_AVX2 + 1];
+			for (int level = SIMD_DECODING_NONE; level <= bestLevel; level++) {
+				setSIMDDecodingLevel(level);
+				int iterations = 0;
+				double elapsed, startTime = getCurrentTime();
+				do {
+					for (int k = 0; k < 16; k++, iterations++) {
+						decompressList(compressed, byteLength, &listLength, output);
+						assert(listLength == LIST_LENGTH);
+					}
+					elapsed = getCurrentTime() - startTime;
+				} while (elapsed < MIN_TIME_PER_MEASUREMENT);
+				for (int i = 0; i < LIST_LENGTH; i++)
+					assert(output[i] == list[i]);
+				nsPerPosting[level] = elapsed * 1E9 / iterations / LIST_LENGTH;
+				printf("  %7.3lf ns", nsPerPosting[level]);
+			}
+			printf("  %9.2lfx\n", nsPerPosting[SIMD_DECODING_NONE] / nsPerPosting[bestLevel]);
+			free(compressed);
+		}
+	}
+	setSIMDDecodingLevel(bestLevel);
+
+	free(list);
+	free(output);
+} // end of measureSIMDDecoding(int, char**)
+
+
 static void mergeIndices(int argc, char **argv) {
 	if (argc < 2) {
 		fprintf(stderr, "Illegal number of parameters. Specify input and output file(s).\n");
@@ -2087,6 +2153,8 @@ int main(int argc, char **argv) {
 		getIndexStatistics(argc - 2, &argv[2]);
 	else if (strcasecmp(argv[1], "MEASURE_DECODING_PERFORMANCE") == 0)
 		measureDecodingPerformance(argc - 2, &argv[2]);
+	else if (strcasecmp(argv[1], "MEASURE_SIMD_DECODING") == 0)
+		measureSIMDDecoding(argc - 2, &argv[2]);
 	else if (strcasecmp(argv[1], "MERGE_INDICES") == 0)
 		mergeIndices(argc - 2, &argv[2]);
 	else if (strcasecmp(argv[1], "RECOMPRESS_INDEX") == 0)
@@ -51,6 +51,7 @@
 #include <string>
 #include <vector>
 #include "index_compression.h"
+#include "index_compression_simd.h"
 #include "index_types.h"
 #include "../feedback/dmc.h"
 #include "../misc/all.h"
@@ -3675,7 +3676,8 @@ offset * decompressVByte(byte *compressed, int byteLength, int *listLength,
 		readHeader(compressed, COMPRESSION_VBYTE, &listLen, &bPtr, outputBuffer);
 	*listLength = listLen;
 
-	byte *bytePtr = &compressed[bPtr];
+	const byte *bytePtr = &compressed[bPtr];
+	const byte *byteLimit = &compressed[byteLength];
 	offset *output = result;
 	offset *limit = &result[listLen];
 
@@ -3686,14 +3688,18 @@ offset * decompressVByte(byte *compressed, int byteLength, int *listLength,
 		offset current;
 		bytePtr += decodeVByteOffset(&current, bytePtr);
 		*output++ = current;
+		decodeVByteGapsSIMD(&bytePtr, byteLimit, &output, limit, &current);
 		while (output != limit) {
 			current += *bytePtr++;
 			*output++ = current;
 		}
 	}
 	else {
-		// otherwise, we switch to the default vByte decoder
+		// otherwise, we switch to the default vByte decoder; the SIMD decoder
+		// (if available) takes care of most of the list, the scalar code below
+		// of whatever is left at the end
 		offset dummy, current = startOffset;
+		decodeVByteGapsSIMD(&bytePtr, byteLimit, &output, limit, &current);
 		unsigned int shift = 0;
 		while (output != limit) {
 			byte b;
@@ -3790,6 +3796,7 @@ offset * decompressGroupVarInt(byte *compressed, int byteLength, int *listLength
 	bool allFitInto8Bits = (compressed[0] >= 128);
 
 	// parse the first posting
+	const byte *start = compressed;
 	compressed = compressed + bytePtr;
 	compressed += decodeVByteOffset(&result[0], compressed);
 	offset current = result[0];
@@ -3797,8 +3804,13 @@ offset * decompressGroupVarInt(byte *compressed, int byteLength, int *listLength
 
 	const uint32_t mask[4] = { 0xFF, 0xFFFF, 0xFFFFFF, 0xFFFFFFFF };
 
-	// decode chunks of 4 postings at a time
+	// decode chunks of 4 postings at a time; start with the SIMD decoder (if
+	// available) and let the scalar code handle the groups near the end of the
+	// compressed buffer, where the SIMD decoder would read past the end
 	const offset *limit = outPtr + (((listLen - 1) / 4) * 4);
+	const byte *groupPtr = compressed;
+	decodeGroupVarIntGapsSIMD(&groupPtr, &start[byteLength], &outPtr, limit, &current);
+	compressed = (byte*)groupPtr;
 	if (allFitInto8Bits) {
 		while (outPtr != limit) {
 			compressed++;
@@ -0,0 +1,402 @@
+/**
+ * Copyright (C) 2007 Stefan Buettcher. All rights reserved.
+ * This is free software with ABSOLUTELY NO WARRANTY.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA
+ **/
+
+/**
+ * Implementation of the SIMD decoders declared in index_compression_simd.h.
+ *
+ * Decoding happens in two stages. The first stage gathers vByte/GroupVarInt
+ * d-gaps into a small buffer of 32-bit integers, using PSHUFB (SSSE3) and
+ * PMOVZX (SSE4.1). The second stage computes the prefix sum over the buffer
+ * and widens the result to 64-bit postings (SSE4.1 or AVX2). GroupVarInt
+ * groups are small enough to do the prefix sum in registers right away.
+ *
+ * The target-specific code is compiled via function attributes, so that the
+ * rest of the system can still be built for a generic x86-64 CPU.
+ *
+ * author: Stefan Buettcher
+ * created: 2026-10-16
+ * changed: 2026-10-16
+ **/
+
+
+#include <pthread.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include "index_compression.h"
+#include "index_compression_simd.h"
+#include "../misc/all.h"
+
+
+#if defined(__GNUC__) && defined(__x86_64__) && (INDEX_OFFSET_BITS == 64)
+	#define SIMD_DECODING_SUPPORTED 1
+	#include <immintrin.h>
+#else
+	#define SIMD_DECODING_SUPPORTED 0
+#endif
+
+
+using namespace std;
+
+
+static int simdDecodingLevel = SIMD_DECODING_NONE;
+static int bestSIMDDecodingLevel = SIMD_DECODING_NONE;
+static pthread_once_t simdDecodingInitialized = PTHREAD_ONCE_INIT;
+
+
+#if SIMD_DECODING_SUPPORTED
+
+/**
+ * Number of d-gaps we gather before running them through the prefix-sum
+ * kernel. The buffer itself is a bit bigger, since a single decoding step
+ * may produce up to 16 gaps.
+ **/
+#define GAP_BUFFER_SIZE 128
+
+/**
+ * Each entry in the Masked-VByte lookup table describes how to decode the
+ * integers found in a 12-byte window, given the continuation bits of the
+ * bytes in that window. Either up to 8 integers of 1-2 bytes are gathered
+ * into 16-bit lanes, or up to 4 integers of 1-4 bytes into 32-bit lanes.
+ * If the first integer is longer than 4 bytes, "count" is 0, and we have to
+ * decode it with the scalar code.
+ **/
+struct MaskedVByteEntry {
+	byte count;
+	byte consumed;
+	byte laneWidth;
+	uint16_t pattern;
+};
+
+#define MASKED_VBYTE_WINDOW 12
+#define MAX_MASKED_VBYTE_PATTERNS 1024
+
+static MaskedVByteEntry maskedVByteTable[1 << MASKED_VBYTE_WINDOW];
+static byte maskedVByteShuffle[MAX_MASKED_VBYTE_PATTERNS][16] __attribute__((aligned(16)));
+
+/** Shuffle masks and total group length (incl. selector) for GroupVarInt. **/
+static byte groupVarIntShuffle[256][16] __attribute__((aligned(16)));
+static byte groupVarIntGroupLength[256];
+
+typedef void (*PrefixSumKernel)(const uint32_t*, int, offset*, offset*);
+
+static PrefixSumKernel prefixSumKernel = NULL;
+
+
+static void initializeMaskedVByteTable() {
+	map<string,int> patternIDs;
+	for (int mask = 0; mask < (1 << MASKED_VBYTE_WINDOW); mask++) {
+		// split the window into integers, according to the continuation bits
+		int lengths[MASKED_VBYTE_WINDOW], starts[MASKED_VBYTE_WINDOW], n = 0;
+		for (int pos = 0, end = 0; pos < MASKED_VBYTE_WINDOW; pos = end + 1) {
+			end = pos;
+			while ((end < MASKED_VBYTE_WINDOW) && (mask & (1 << end)))
+				end++;
+			if (end >= MASKED_VBYTE_WINDOW)
+				break;
+			starts[n] = pos;
+			lengths[n++] = end - pos + 1;
+		}
+
+		int count16 = 0, count32 = 0;
+		while ((count16 < n) && (count16 < 8) && (lengths[count16] <= 2))
+			count16++;
+		while ((count32 < n) && (count32 < 4) && (lengths[count32] <= 4))
+			count32++;
+
+		MaskedVByteEntry *entry = &maskedVByteTable[mask];
+		byte pattern[16];
+		memset(pattern, 0x80, sizeof(pattern));
+		entry->consumed = 0;
+		if ((count16 == 0) && (count32 == 0)) {
+			entry->count = 0;
+			entry->laneWidth = 0;
+		}
+		else if (count16 >= count32) {
+			entry->count = count16;
+			entry->laneWidth = 16;
+			for (int i = 0; i < count16; i++) {
+				for (int k = 0; k < lengths[i]; k++)
+					pattern[2 * i + k] = starts[i] + k;
+				entry->consumed += lengths[i];
+			}
+		}
+		else {
+			entry->count = count32;
+			entry->laneWidth = 32;
+			for (int i = 0; i < count32; i++) {
+				for (int k = 0; k < lengths[i]; k++)
+					pattern[4 * i + k] = starts[i] + k;
+				entry->consumed += lengths[i];
+			}
+		}
+
+		string key((char*)pattern, sizeof(pattern));
+		if (patternIDs.find(key) == patternIDs.end()) {
+			int id = patternIDs.size();
+			assert(id < MAX_MASKED_VBYTE_PATTERNS);
+			memcpy(maskedVByteShuffle[id], pattern, sizeof(pattern));
+			patternIDs[key] = id;
+		}
+		entry->pattern = patternIDs[key];
+	}
+} // end of initializeMaskedVByteTable()
+
+
+static void initializeGroupVarIntTable() {
+	for (int selector = 0; selector < 256; selector++) {
+		byte *pattern = groupVarIntShuffle[selector];
+		memset(pattern, 0x80, 16);
+		int pos = 0;
+		for (int i = 0; i < 4; i++) {
+			int numBytes = ((selector >> (2 * i)) & 3) + 1;
+			for (int k = 0; k < numBytes; k++)
+				pattern[4 * i + k] = pos++;
+		}
+		groupVarIntGroupLength[selector] = 1 + pos;
+	}
+} // end of initializeGroupVarIntTable()
+
+
+__attribute__((target("sse4.1")))
+static void prefixSum_SSE41(const uint32_t *gaps, int count, offset *current, offset *out) {
+	__m128i sum = _mm_set1_epi64x(*current);
+	int i = 0;
+	for (; i + 2 <= count; i += 2) {
+		__m128i x = _mm_cvtepu32_epi64(_mm_loadl_epi64((const __m128i*)&gaps[i]));
+		x = _mm_add_epi64(x, _mm_slli_si128(x, 8));
+		x = _mm_add_epi64(x, sum);
+		_mm_storeu_si128((__m128i*)&out[i], x);
+		sum = _mm_unpackhi_epi64(x, x);
+	}
+	offset value = _mm_cvtsi128_si64(sum);
+	for (; i < count; i++)
+		out[i] = (value += gaps[i]);
+	*current = value;
+} // end of prefixSum_SSE41(const uint32_t*, int, offset*, offset*)
+
+
+__attribute__((target("avx2")))
+static void prefixSum_AVX2(const uint32_t *gaps, int count, offset *current, offset *out) {
+	__m256i sum = _mm256_set1_epi64x(*current);
+	const __m256i zero = _mm256_setzero_si256();
+	int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m256i x = _mm256_cvtepu32_epi64(_mm_loadu_si128((const __m128i*)&gaps[i]));
+		// prefix sum within each 128-bit lane, then carry lane 1 into lanes 2, 3
+		x = _mm256_add_epi64(x, _mm256_slli_si256(x, 8));
+		x = _mm256_add_epi64(x,
+				_mm256_blend_epi32(zero, _mm256_permute4x64_epi64(x, 0x55), 0xF0));
+		x = _mm256_add_epi64(x, sum);
+		_mm256_storeu_si256((__m256i*)&out[i], x);
+		sum = _mm256_permute4x64_epi64(x, 0xFF);
+	}
+	offset value = _mm_cvtsi128_si64(_mm256_castsi256_si128(sum));
+	for (; i < count; i++)
+		out[i] = (value += gaps[i]);
+	*current = value;
+} // end of prefixSum_AVX2(const uint32_t*, int, offset*, offset*)
+
+
+__attribute__((target("sse4.1")))
+static int decodeVByteGaps_SSE41(const byte **input, const byte *inputEnd,
+		offset **output, const offset *outputEnd, offset *current) {
+	const byte *in = *input;
+	offset *out = *output;
+	offset *const outStart = out;
+	offset value = *current;
+	uint32_t gaps[GAP_BUFFER_SIZE + 16];
+	int pending = 0;
+
+	const __m128i lowBits = _mm_set1_epi16(0x007F);
+	const __m128i highBits = _mm_set1_epi16(0x7F00);
+	const __m128i payload = _mm_set1_epi8(0x7F);
+	const __m128i bits7 = _mm_set1_epi32(0x7F << 7);
+	const __m128i bits14 = _mm_set1_epi32(0x7F << 14);
+	const __m128i bits21 = _mm_set1_epi32(0x7F << 21);
+
+	while ((in + 16 <= inputEnd) && (out + pending + 16 <= outputEnd)) {
+		const __m128i data = _mm_loadu_si128((const __m128i*)in);
+		const int continuation = _mm_movemask_epi8(data);
+		if (continuation == 0) {
+			// 16 single-byte gaps; very common for frequent terms
+			_mm_storeu_si128((__m128i*)&gaps[pending + 0], _mm_cvtepu8_epi32(data));
+			_mm_storeu_si128((__m128i*)&gaps[pending + 4], _mm_cvtepu8_epi32(_mm_srli_si128(data, 4)));
+			_mm_storeu_si128((__m128i*)&gaps[pending + 8], _mm_cvtepu8_epi32(_mm_srli_si128(data, 8)));
+			_mm_storeu_si128((__m128i*)&gaps[pending + 12], _mm_cvtepu8_epi32(_mm_srli_si128(data, 12)));
+			pending += 16;
+			in += 16;
+		}
+		else {
+			const MaskedVByteEntry *entry =
+				&maskedVByteTable[continuation & ((1 << MASKED_VBYTE_WINDOW) - 1)];
+			if (entry->count == 0) {
+				// gap needs more than 4 bytes; flush buffer and decode with scalar code
+				prefixSumKernel(gaps, pending, &value, out);
+				out += pending;
+				pending = 0;
+				offset gap;
+				in += decodeVByteOffset(&gap, in);
+				*out++ = (value += gap);
+				continue;
+			}
+			const __m128i pattern =
+				_mm_load_si128((const __m128i*)maskedVByteShuffle[entry->pattern]);
+			const __m128i shuffled = _mm_shuffle_epi8(data, pattern);
+			if (entry->laneWidth == 16) {
+				const __m128i x = _mm_or_si128(_mm_and_si128(shuffled, lowBits),
+						_mm_srli_epi16(_mm_and_si128(shuffled, highBits), 1));
+				_mm_storeu_si128((__m128i*)&gaps[pending + 0], _mm_cvtepu16_epi32(x));
+				_mm_storeu_si128((__m128i*)&gaps[pending + 4], _mm_cvtepu16_epi32(_mm_srli_si128(x, 8)));
+			}
+			else {
+				const __m128i v = _mm_and_si128(shuffled, payload);
+				__m128i x = _mm_and_si128(v, _mm_set1_epi32(0x7F));
+				x = _mm_or_si128(x, _mm_and_si128(_mm_srli_epi32(v, 1), bits7));
+				x = _mm_or_si128(x, _mm_and_si128(_mm_srli_epi32(v, 2), bits14));
+				x = _mm_or_si128(x, _mm_and_si128(_mm_srli_epi32(v, 3), bits21));
+				_mm_storeu_si128((__m128i*)&gaps[pending], x);
+			}
+			pending += entry->count;
+			in += entry->consumed;
+		}
+		if (pending >= GAP_BUFFER_SIZE) {
+			prefixSumKernel(gaps, pending, &value, out);
+			out += pending;
+			pending = 0;
+		}
+	}
+	prefixSumKernel(gaps, pending, &value, out);
+	out += pending;
+
+	*input = in;
+	*output = out;
+	*current = value;
+	return out - outStart;
+} // end of decodeVByteGaps_SSE41(...)
+
+
+__attribute__((target("sse4.1")))
+static int decodeGroupVarIntGaps_SSE41(const byte **input, const byte *inputEnd,
+		offset **output, const offset *outputEnd, offset *current) {
+	const byte *in = *input;
+	offset *out = *output;
+	offset *const outStart = out;
+
+	// the payload of a group is at most 16 bytes, following the selector byte;
+	// groups are short enough to compute the prefix sum in registers directly
+	__m128i sum = _mm_set1_epi64x(*current);
+	while ((in + 17 <= inputEnd) && (out + 4 <= outputEnd)) {
+		const int selector = in[0];
+		const __m128i data = _mm_loadu_si128((const __m128i*)(in + 1));
+		const __m128i pattern = _mm_load_si128((const __m128i*)groupVarIntShuffle[selector]);
+		const __m128i x = _mm_shuffle_epi8(data, pattern);
+		__m128i lo = _mm_cvtepu32_epi64(x);
+		__m128i hi = _mm_cvtepu32_epi64(_mm_srli_si128(x, 8));
+		lo = _mm_add_epi64(lo, _mm_slli_si128(lo, 8));
+		hi = _mm_add_epi64(hi, _mm_slli_si128(hi, 8));
+		lo = _mm_add_epi64(lo, sum);
+		hi = _mm_add_epi64(hi, _mm_unpackhi_epi64(lo, lo));
+		_mm_storeu_si128((__m128i*)&out[0], lo);
+		_mm_storeu_si128((__m128i*)&out[2], hi);
+		sum = _mm_unpackhi_epi64(hi, hi);
+		out += 4;
+		in += groupVarIntGroupLength[selector];
+	}
+
+	*input = in;
+	*output = out;
+	*current = _mm_cvtsi128_si64(sum);
+	return out - outStart;
+} // end of decodeGroupVarIntGaps_SSE41(...)
+
+#endif // SIMD_DECODING_SUPPORTED
+
+
+static void initializeSIMDDecoding() {
+#if SIMD_DECODING_SUPPORTED
+	__builtin_cpu_init();
+	if ((__builtin_cpu_supports("ssse3")) && (__builtin_cpu_supports("sse4.1"))) {
+		initializeMaskedVByteTable();
+		initializeGroupVarIntTable();
+		bestSIMDDecodingLevel = SIMD_DECODING_SSE41;
+		if (__builtin_cpu_supports("avx2"))
+			bestSIMDDecodingLevel = SIMD_DECODING_AVX2;
+	}
+	simdDecodingLevel = bestSIMDDecodingLevel;
+	prefixSumKernel =
+		(simdDecodingLevel == SIMD_DECODING_AVX2 ? prefixSum_AVX2 : prefixSum_SSE41);
+#endif
+} // end of initializeSIMDDecoding()
+
+
+int getSIMDDecodingLevel() {
+	pthread_once(&simdDecodingInitialized, initializeSIMDDecoding);
+	return simdDecodingLevel;
+} // end of getSIMDDecodingLevel()
+
+
+int setSIMDDecodingLevel(int level) {
+	pthread_once(&simdDecodingInitialized, initializeSIMDDecoding);
+	if (level > bestSIMDDecodingLevel)
+		level = bestSIMDDecodingLevel;
+	if (level < SIMD_DECODING_NONE)
+		level = SIMD_DECODING_NONE;
+	simdDecodingLevel = level;
+#if SIMD_DECODING_SUPPORTED
+	prefixSumKernel =
+		(simdDecodingLevel == SIMD_DECODING_AVX2 ? prefixSum_AVX2 : prefixSum_SSE41);
+#endif
+	return simdDecodingLevel;
+} // end of setSIMDDecodingLevel(int)
+
+
+const char *getSIMDDecodingLevelName(int level) {
+	switch (level) {
+		case SIMD_DECODING_SSE41:
+			return "SSE4.1";
+		case SIMD_DECODING_AVX2:
+			return "AVX2";
+		default:
+			return "scalar";
+	}
+} // end of getSIMDDecodingLevelName(int)
+
+
+int decodeVByteGapsSIMD(const byte **input, const byte *inputEnd,
+		offset **output, const offset *outputEnd, offset *current) {
+#if SIMD_DECODING_SUPPORTED
+	if (getSIMDDecodingLevel() != SIMD_DECODING_NONE)
+		return decodeVByteGaps_SSE41(input, inputEnd, output, outputEnd, current);
+#endif
+	return 0;
+} // end of decodeVByteGapsSIMD(...)
+
+
+int decodeGroupVarIntGapsSIMD(const byte **input, const byte *inputEnd,
+		offset **output, const offset *outputEnd, offset *current) {
+#if SIMD_DECODING_SUPPORTED
+	if (getSIMDDecodingLevel() != SIMD_DECODING_NONE)
+		return decodeGroupVarIntGaps_SSE41(input, inputEnd, output, outputEnd, current);
+#endif
+	return 0;
+} // end of decodeGroupVarIntGapsSIMD(...)
+
+
@@ -0,0 +1,94 @@
+/**
+ * Copyright (C) 2007 Stefan Buettcher. All rights reserved.
+ * This is free software with ABSOLUTELY NO WARRANTY.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA
+ **/
+
+/**
+ * SIMD decoding kernels for vByte- and GroupVarInt-compressed posting lists.
+ * The vByte decoder follows the Masked-VByte approach (Plaisance, Kurz, and
+ * Lemire, "Vectorized VByte Decoding", 2015): the continuation bits of the
+ * next 12 input bytes select an entry in a shuffle table that tells us how
+ * to gather up to 8 encoded integers into SIMD lanes. GroupVarInt selectors
+ * are mapped to shuffle masks directly (as in Stream-VByte). The decoded
+ * d-gaps are then turned into postings by a prefix-sum kernel.
+ *
+ * The decoder to use is chosen at runtime, based on the capabilities of the
+ * CPU we are running on. All functions here produce exactly the same output
+ * as their scalar counterparts in index_compression.cpp; they only process
+ * the "easy" part of the input and leave the rest (e.g., d-gaps that need
+ * more than 28 bits, or the last few bytes of a list) to the scalar code.
+ *
+ * author: Stefan Buettcher
+ * created: 2026-10-16
+ * changed: 2026-10-16
+ **/
+
+
+#ifndef __INDEX__INDEX_COMPRESSION_SIMD_H
+#define __INDEX__INDEX_COMPRESSION_SIMD_H
+
+
+#include "index_types.h"
+
+
+/** Instruction set levels supported by the SIMD decoders. **/
+#define SIMD_DECODING_NONE       0
+#define SIMD_DECODING_SSE41      1
+#define SIMD_DECODING_AVX2       2
+
+
+/**
+ * Returns the SIMD level currently used for decoding. The first call
+ * inspects the CPU and selects the best level available.
+ **/
+int getSIMDDecodingLevel();
+
+/**
+ * Changes the SIMD level used for decoding. Requests for a level not
+ * supported by the CPU are capped at the best level available. Returns the
+ * level actually selected. This is mainly useful for benchmarking against
+ * the scalar code (SIMD_DECODING_NONE).
+ **/
+int setSIMDDecodingLevel(int level);
+
+/** Returns a human-readable name for the given SIMD level. **/
+const char *getSIMDDecodingLevelName(int level);
+
+
+/**
+ * Decodes vByte-encoded d-gaps from "*input" into "*output", adding each gap
+ * to "*current" and storing the running sum. Stops when fewer than 16 input
+ * bytes are left before "inputEnd", when fewer than 16 output slots are left
+ * before "outputEnd", or when it encounters a d-gap that does not fit into
+ * 4 vByte bytes. Updates all three pointers and returns the number of
+ * postings produced (0 if no SIMD decoder is available).
+ **/
+int decodeVByteGapsSIMD(const byte **input, const byte *inputEnd,
+		offset **output, const offset *outputEnd, offset *current);
+
+/**
+ * Same as above, but for GroupVarInt groups (1 selector byte followed by
+ * 4 gaps of 1-4 bytes each). Only complete groups of 4 are decoded.
+ **/
+int decodeGroupVarIntGapsSIMD(const byte **input, const byte *inputEnd,
+		offset **output, const offset *outputEnd, offset *current);
+
+
+#endif
+
+
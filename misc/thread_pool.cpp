@@ -0,0 +1,278 @@
+/**
+ * Copyright (C) 2007 Stefan Buettcher. All rights reserved.
+ * This is free software with ABSOLUTELY NO WARRANTY.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA
+ **/
+/**
+ * Implementation of the ThreadPool class.
+ *
+ * author: Stefan Buettcher
+ * created: 2026-10-16
+ * changed: 2026-10-16
+ **/
+
+
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include "thread_pool.h"
+#include "../misc/all.h"
+
+
+static const char * LOG_ID = "ThreadPool";
+
+/**
+ * The worker descriptor of the current thread, if it belongs to a pool. Used
+ * to put jobs submitted by a worker into the worker's own queue.
+ **/
+static __thread void *currentWorker = NULL;
+
+
+ThreadPool::ThreadPool(const char *name, int workerCount, int maxQueueLength) {
+	if (workerCount < 1)
+		workerCount = 1;
+	if (workerCount > MAX_WORKER_COUNT)
+		workerCount = MAX_WORKER_COUNT;
+	if (maxQueueLength < 1)
+		maxQueueLength = 1;
+	this->name = duplicateString(name);
+	this->workerCount = workerCount;
+	this->maxQueueLength = maxQueueLength;
+	queuedJobCount = 0;
+	jobsRejected = 0;
+	shutdownRequested = false;
+	SEM_INIT(jobsAvailable, 0);
+
+	workers = new Worker[workerCount];
+	for (int i = 0; i < workerCount; i++) {
+		Worker *w = &workers[i];
+		w->pool = this;
+		w->id = i;
+		SEM_INIT(w->queueSemaphore, 1);
+		w->maxQueueLength = 0;
+		w->jobsExecuted = w->jobsStolen = w->jobsExpired = 0;
+		w->totalWaitTime = w->maxWaitTime = 0.0;
+	}
+	for (int i = 0; i < workerCount; i++) {
+		if (pthread_create(&workers[i].thread, NULL, workerStarter, &workers[i]) != 0) {
+			log(LOG_ERROR, LOG_ID, "Unable to create worker thread.");
+			assert(false);
+		}
+	}
+
+	sprintf(errorMessage, "Thread pool \"%s\" started: %d workers, queue length %d.",
+			name, workerCount, maxQueueLength);
+	log(LOG_DEBUG, LOG_ID, errorMessage);
+} // end of ThreadPool(char*, int, int)
+
+
+ThreadPool::~ThreadPool() {
+	getLock();
+	shutdownRequested = true;
+	releaseLock();
+	for (int i = 0; i < workerCount; i++)
+		sem_post(&jobsAvailable);
+	for (int i = 0; i < workerCount; i++)
+		pthread_join(workers[i].thread, NULL);
+
+	// tell all jobs that never made it to a worker that they will not be run
+	for (int i = 0; i < workerCount; i++) {
+		while (!workers[i].queue.empty()) {
+			Job job = workers[i].queue.front();
+			workers[i].queue.pop_front();
+			job.task(job.data, true);
+		}
+		sem_destroy(&workers[i].queueSemaphore);
+	}
+	sem_destroy(&jobsAvailable);
+	delete[] workers;
+	free(name);
+} // end of ~ThreadPool()
+
+
+bool ThreadPool::submit(ThreadPoolTask task, void *data, int timeoutMillis) {
+	Job job;
+	job.task = task;
+	job.data = data;
+	job.submitTime = getCurrentTime();
+	job.deadline = (timeoutMillis > 0 ? job.submitTime + 0.001 * timeoutMillis : 0.0);
+
+	getLock();
+	if ((shutdownRequested) || (queuedJobCount >= maxQueueLength)) {
+		jobsRejected++;
+		releaseLock();
+		return false;
+	}
+	queuedJobCount++;
+	releaseLock();
+
+	// jobs created by one of our own workers stay with that worker; everything
+	// else goes to the worker with the shortest queue
+	Worker *target = (Worker*)currentWorker;
+	if ((target == NULL) || (target->pool != this)) {
+		target = &workers[0];
+		for (int i = 1; i < workerCount; i++)
+			if (workers[i].queue.size() < target->queue.size())
+				target = &workers[i];
+	}
+
+	sem_wait(&target->queueSemaphore);
+	target->queue.push_back(job);
+	if (target->queue.size() > target->maxQueueLength)
+		target->maxQueueLength = target->queue.size();
+	sem_post(&target->queueSemaphore);
+
+	sem_post(&jobsAvailable);
+	return true;
+} // end of submit(ThreadPoolTask, void*, int)
+
+
+int ThreadPool::getWorkerCount() {
+	return workerCount;
+}
+
+
+int ThreadPool::getQueueLength() {
+	LocalLock lock(this);
+	return queuedJobCount;
+}
+
+
+bool ThreadPool::takeJob(Worker *worker, Job *job, bool *stolen) {
+	// own queue first, oldest job first
+	sem_wait(&worker->queueSemaphore);
+	if (!worker->queue.empty()) {
+		*job = worker->queue.front();
+		worker->queue.pop_front();
+		sem_post(&worker->queueSemaphore);
+		*stolen = false;
+		return true;
+	}
+	sem_post(&worker->queueSemaphore);
+
+	// then try to steal from the end of someone else's queue
+	for (int i = 1; i < workerCount; i++) {
+		Worker *victim = &workers[(worker->id + i) % workerCount];
+		if (victim->queue.empty())
+			continue;
+		sem_wait(&victim->queueSemaphore);
+		if (!victim->queue.empty()) {
+			*job = victim->queue.back();
+			victim->queue.pop_back();
+			sem_post(&victim->queueSemaphore);
+			*stolen = true;
+			return true;
+		}
+		sem_post(&victim->queueSemaphore);
+	}
+	return false;
+} // end of takeJob(Worker*, Job*, bool*)
+
+
+void ThreadPool::workerLoop(Worker *worker) {
+	currentWorker = worker;
+	while (true) {
+		sem_wait(&jobsAvailable);
+
+		// every post to "jobsAvailable" corresponds to one job in one of the
+		// queues; if we cannot find it right away, somebody else grabbed it and
+		// we will find theirs
+		Job job;
+		bool stolen;
+		bool found = takeJob(worker, &job, &stolen);
+		while ((!found) && (!shutdownRequested)) {
+			sched_yield();
+			found = takeJob(worker, &job, &stolen);
+		}
+		if (!found)
+			break;
+
+		getLock();
+		queuedJobCount--;
+		releaseLock();
+
+		double now = getCurrentTime();
+		double waitTime = now - job.submitTime;
+		bool expired = ((job.deadline > 0.0) && (now > job.deadline));
+		if (shutdownRequested)
+			expired = true;
+
+		sem_wait(&worker->queueSemaphore);
+		worker->jobsExecuted++;
+		if (stolen)
+			worker->jobsStolen++;
+		if (expired)
+			worker->jobsExpired++;
+		worker->totalWaitTime += waitTime;
+		if (waitTime > worker->maxWaitTime)
+			worker->maxWaitTime = waitTime;
+		sem_post(&worker->queueSemaphore);
+
+		job.task(job.data, expired);
+	}
+	currentWorker = NULL;
+} // end of workerLoop(Worker*)
+
+
+void * ThreadPool::workerStarter(void *data) {
+	Worker *worker = (Worker*)data;
+	worker->pool->workerLoop(worker);
+	return NULL;
+} // end of workerStarter(void*)
+
+
+void ThreadPool::getStatistics(char *buffer, int bufferSize) {
+	char line[256];
+	getLock();
+	snprintf(line, sizeof(line),
+			"%s: %d workers, %d/%d jobs queued, %lld rejected\n",
+			name, workerCount, queuedJobCount, maxQueueLength, jobsRejected);
+	releaseLock();
+	int len = strlen(line);
+	if (len >= bufferSize)
+		len = bufferSize - 1;
+	memcpy(buffer, line, len);
+
+	for (int i = 0; i < workerCount; i++) {
+		Worker *w = &workers[i];
+		sem_wait(&w->queueSemaphore);
+		double avgWait = (w->jobsExecuted > 0 ? w->totalWaitTime / w->jobsExecuted : 0.0);
+		snprintf(line, sizeof(line),
+				"worker %d: queue %d (max %d), executed %lld, stolen %lld, expired %lld, "
+				"wait %.2f ms (max %.2f ms)\n",
+				i, (int)w->queue.size(), w->maxQueueLength, w->jobsExecuted,
+				w->jobsStolen, w->jobsExpired, avgWait * 1000, w->maxWaitTime * 1000);
+		sem_post(&w->queueSemaphore);
+		int lineLen = strlen(line);
+		if (len + lineLen >= bufferSize)
+			break;
+		memcpy(&buffer[len], line, lineLen);
+		len += lineLen;
+	}
+
+	// remove trailing newline
+	if ((len > 0) && (buffer[len - 1] == '\n'))
+		len--;
+	buffer[len] = 0;
+} // end of getStatistics(char*, int)
+
+
+void ThreadPool::getClassName(char *target) {
+	strcpy(target, "ThreadPool");
+}
+
+
@@ -0,0 +1,166 @@
+/**
+ * Copyright (C) 2007 Stefan Buettcher. All rights reserved.
+ * This is free software with ABSOLUTELY NO WARRANTY.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA
+ **/
+
+/**
+ * The ThreadPool class implements a fixed-size pool of worker threads. Every
+ * worker has its own job queue. New jobs are put into the shortest queue (or,
+ * if submitted by one of the workers, into the worker's own queue). Idle
+ * workers steal jobs from the end of other workers' queues.
+ *
+ * The total number of queued jobs is bounded; submit() refuses new jobs when
+ * the limit has been reached. Jobs may carry a deadline. If a job has been
+ * waiting in a queue for longer than that, it is not executed, but its task
+ * function is called with "expired" set to true, so that it can release its
+ * resources and tell the client what happened.
+ *
+ * author: Stefan Buettcher
+ * created: 2026-10-16
+ * changed: 2026-10-16
+ **/
+
+
+#ifndef __MISC__THREAD_POOL_H
+#define __MISC__THREAD_POOL_H
+
+
+#include <deque>
+#include <pthread.h>
+#include <semaphore.h>
+#include "lockable.h"
+
+
+/**
+ * Functions of this type are executed by the worker threads. "data" is the
+ * pointer given to submit(). "expired" is true if the job's deadline passed
+ * before a worker could get to it.
+ **/
+typedef void (*ThreadPoolTask)(void *data, bool expired);
+
+
+class ThreadPool : public Lockable {
+
+public:
+
+	/** Upper limit for the number of worker threads in a pool. **/
+	static const int MAX_WORKER_COUNT = 256;
+
+private:
+
+	struct Job {
+		ThreadPoolTask task;
+		void *data;
+		double submitTime;
+		double deadline;
+	};
+
+	struct Worker {
+		ThreadPool *pool;
+		int id;
+		pthread_t thread;
+
+		/** Protects the job queue and the statistics below. **/
+		sem_t queueSemaphore;
+		std::deque<Job> queue;
+
+		/** Per-worker statistics, reported by getStatistics. **/
+		int maxQueueLength;
+		long long jobsExecuted;
+		long long jobsStolen;
+		long long jobsExpired;
+		double totalWaitTime;
+		double maxWaitTime;
+	};
+
+	/** Name of the pool, for logging and statistics. **/
+	char *name;
+
+	/** Worker threads and their queues. **/
+	Worker *workers;
+	int workerCount;
+
+	/** Maximum number of jobs waiting in all queues combined. **/
+	int maxQueueLength;
+
+	/** Number of jobs currently waiting in all queues combined. **/
+	int queuedJobCount;
+
+	/** Number of jobs refused by submit() because all queues were full. **/
+	long long jobsRejected;
+
+	/** Counts jobs that have been queued, but not yet claimed by a worker. **/
+	sem_t jobsAvailable;
+
+	/** Set by the destructor to tell all workers to terminate. **/
+	bool shutdownRequested;
+
+public:
+
+	/**
+	 * Creates a new pool with "workerCount" worker threads that accepts up to
+	 * "maxQueueLength" waiting jobs. The name is used for statistics only.
+	 **/
+	ThreadPool(const char *name, int workerCount, int maxQueueLength);
+
+	/**
+	 * Waits for all running jobs to finish and stops the workers. Jobs that
+	 * are still waiting in a queue are called with "expired" set to true.
+	 **/
+	~ThreadPool();
+
+	/**
+	 * Puts a new job into one of the queues. If "timeoutMillis" is positive,
+	 * the job expires if it has not been started after that many milliseconds.
+	 * Returns false (and does not take the job) if the queues are full.
+	 **/
+	bool submit(ThreadPoolTask task, void *data, int timeoutMillis);
+
+	/** Returns the number of worker threads in this pool. **/
+	int getWorkerCount();
+
+	/** Returns the number of jobs currently waiting in all queues. **/
+	int getQueueLength();
+
+	/**
+	 * Prints per-worker queue depth, job counts, and queue wait times into the
+	 * given buffer, one line per worker, preceded by a summary line.
+	 **/
+	void getStatistics(char *buffer, int bufferSize);
+
+	virtual void getClassName(char *target);
+
+private:
+
+	/** Main loop of every worker thread. **/
+	void workerLoop(Worker *worker);
+
+	/**
+	 * Takes a job from the worker's own queue or, if that is empty, steals one
+	 * from another worker. Returns false if no job could be found.
+	 **/
+	bool takeJob(Worker *worker, Job *job, bool *stolen);
+
+	static void *workerStarter(void *data);
+
+}; // end of class ThreadPool
+
+
+#endif
+
+
@@ -23,13 +23,14 @@
  *
  * author: Stefan Buettcher
  * created: 2004-09-28
- * changed: 2009-02-01
+ * changed: 2026-10-16
  **/
 
 
 #include <assert.h>
 #include <string.h>
 #include "miscquery.h"
+#include "../daemons/query_executor.h"
 #include "../extentlist/extentlist.h"
 #include "../misc/all.h"
 #include "../stemming/stemmer.h"
@@ -153,6 +154,15 @@ MiscQuery::MiscQuery(Index *index, const char *command, const char **modifiers,
 				resultLine[strlen(resultLine) - 1] = 0;
 		ok = true;
 	}
+	else if (strcasecmp(command, "querypool") == 0) {
+		if (body[0] != 0) {
+			takesNoArgumentsError(resultLine, command);
+			ok = false;
+			return;
+		}
+		QueryExecutor::getThreadPool()->getStatistics(resultLine, MAX_RESULT_LENGTH);
+		ok = true;
+	}
 	else if (strcasecmp(command, "filestats") == 0) {
 		if (body[0] != 0) {
 			takesNoArgumentsError(resultLine, command);
@@ -26,7 +26,7 @@
  *
  * author: Stefan Buettcher
  * created: 2004-09-28
- * changed: 2009-02-01
+ * changed: 2026-10-16
  **/
 
 
@@ -44,7 +44,7 @@ class MiscQuery : public Query {
 private:
 
 	/** Maximum length of the result line. **/
-	static const int MAX_RESULT_LENGTH = 1024;
+	static const int MAX_RESULT_LENGTH = 16384;
 
 	char *resultLine;
 
@@ -124,6 +124,20 @@ REGISTER_QUERY_CLASS(MiscQuery, summary,
 	"This information is not useful unless the MasterIndex class is used to manage\n" \
 	"index data for multiple file systems."
 )
+REGISTER_QUERY_CLASS(MiscQuery, querypool,
+	"Prints queue and wait-time statistics for the query thread pool.",
+	"The first line summarizes the pool (number of workers, waiting queries,\n" \
+	"rejected queries). It is followed by one line per worker thread, giving\n" \
+	"current and maximum queue depth, number of queries executed, stolen from\n" \
+	"other workers, and dropped because of QUERY_DEADLINE, as well as average\n" \
+	"and maximum time spent in the queue.\n\n" \
+	"Example:\n\n" \
+	"  @querypool\n" \
+	"  query: 2 workers, 0/256 jobs queued, 0 rejected\n" \
+	"  worker 0: queue 0 (max 3), executed 117, stolen 4, expired 0, wait 0.05 ms (max 1.20 ms)\n" \
+	"  worker 1: queue 0 (max 2), executed 98, stolen 9, expired 0, wait 0.04 ms (max 0.93 ms)\n" \
+	"  @0-Ok. (0 ms)"
+)
 
 
 #endif
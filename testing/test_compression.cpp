@@ -9,6 +9,7 @@
 #include <stdlib.h>
 #include "testing.h"
 #include "../index/index_compression.h"
+#include "../index/index_compression_simd.h"
 #include "../index/index_types.h"
 #include "../misc/alloc.h"
 
@@ -120,4 +121,64 @@ void TESTCASE_PostingsCompression(int *passed, int *failed) {
 } // end of TESTCASE_PostingsCompression(int*, int*)
 
 
+void TESTCASE_SIMDDecoding(int *passed, int *failed) {
+	*passed = *failed = 0;
+	const int bestLevel = getSIMDDecodingLevel();
+	const int methods[2] = { COMPRESSION_VBYTE, COMPRESSION_GROUPVARINT };
+
+	// mix small gaps (7-bit fast path), medium gaps (Masked-VByte) and the
+	// occasional huge gap (> 4 vByte bytes) that needs the scalar fallback
+	for (int len = 1; len < 50000; len += (random() % len) + 1) {
+		for (int maxBits = 1; maxBits <= 40; maxBits += 3) {
+			offset *list = typed_malloc(offset, len);
+			offset prev = 0;
+			for (int i = 0; i < len; i++) {
+				int bits = (random() % 16 == 0 ? maxBits : random() % maxBits + 1);
+				offset gap = ((((offset)random()) << 31) | random()) & ((1LL << bits) - 1);
+				prev += gap + 1;
+				list[i] = prev;
+			}
+			for (int m = 0; m < 2; m++) {
+				int byteLen, scalarLen, simdLen;
+				byte *compressed = compressorForID[methods[m]](list, len, &byteLen);
+
+				// vByte lists can also be decoded relative to a start offset
+				bool isVByte = (extractCompressionModeFromList(compressed) == COMPRESSION_VBYTE);
+				setSIMDDecodingLevel(SIMD_DECODING_NONE);
+				offset *scalar = (isVByte ?
+					decompressVByte(compressed, byteLen, &scalarLen, NULL, 4711) :
+					decompressList(compressed, byteLen, &scalarLen, NULL));
+
+				for (int level = SIMD_DECODING_SSE41; level <= bestLevel; level++) {
+					setSIMDDecodingLevel(level);
+					offset *simd = decompressList(compressed, byteLen, &simdLen, NULL);
+					offset *simdShifted = (isVByte ?
+						decompressVByte(compressed, byteLen, &simdLen, NULL, 4711) : NULL);
+					bool ok = (scalarLen == len) && (simdLen == len);
+					for (int i = 0; (ok) && (i < len); i++) {
+						if ((simd[i] != list[i]) ||
+						    ((isVByte) && (simdShifted[i] != scalar[i])) ||
+						    ((!isVByte) && (scalar[i] != list[i]))) {
+							fprintf(stderr, "SIMD decoding mismatch for method %d, level %s, position %d.\n",
+							        methods[m], getSIMDDecodingLevelName(level), i);
+							ok = false;
+						}
+					}
+					if (ok)
+						*passed = *passed + 1;
+					else
+						*failed = *failed + 1;
+					free(simd);
+					if (simdShifted != NULL)
+						free(simdShifted);
+				}
+				setSIMDDecodingLevel(bestLevel);
+				free(compressed);
+				free(scalar);
+			}
+			free(list);
+		}
+	}
+} // end of TESTCASE_SIMDDecoding(int*, int*)
+
 
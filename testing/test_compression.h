@@ -14,6 +14,7 @@
 
 REGISTER_TEST_CASE(BasicVByte);
 REGISTER_TEST_CASE(PostingsCompression);
+REGISTER_TEST_CASE(SIMDDecoding);
 
 
 #endif
@@ -1,13 +1,16 @@
 /**
  * author: Stefan Buettcher
  * created: 2007-11-18
- * changed: 2007-11-18
+ * changed: 2026-10-16
  **/
 
 
+#include <semaphore.h>
 #include <stdlib.h>
+#include <string.h>
 #include "testing.h"
 #include "../index/index_types.h"
+#include "../misc/thread_pool.h"
 #include "../misc/utils.h"
 
 
@@ -30,4 +33,72 @@ void TESTCASE_StartsWithEndsWith(int *passed, int *failed) {
 } // end of TESTCASE_StartsWithEndsWith(int*, int*)
 
 
+struct ThreadPoolTestData {
+	int executed;
+	int expired;
+	sem_t blocker;
+};
+
+
+static void countingTask(void *data, bool expired) {
+	ThreadPoolTestData *d = (ThreadPoolTestData*)data;
+	if (expired)
+		__sync_fetch_and_add(&d->expired, 1);
+	else
+		__sync_fetch_and_add(&d->executed, 1);
+} // end of countingTask(void*, bool)
+
+
+static void blockingTask(void *data, bool expired) {
+	ThreadPoolTestData *d = (ThreadPoolTestData*)data;
+	sem_wait(&d->blocker);
+	countingTask(data, expired);
+} // end of blockingTask(void*, bool)
+
+
+void TESTCASE_ThreadPool(int *passed, int *failed) {
+	*passed = *failed = 0;
+
+	// all jobs get executed exactly once
+	ThreadPoolTestData d;
+	d.executed = d.expired = 0;
+	sem_init(&d.blocker, 0, 0);
+	ThreadPool *pool = new ThreadPool("test", 3, 1000);
+	EXPECT(pool->getWorkerCount() == 3);
+	bool allAccepted = true;
+	for (int i = 0; i < 500; i++)
+		if (!pool->submit(countingTask, &d, 0))
+			allAccepted = false;
+	EXPECT(allAccepted);
+	while (pool->getQueueLength() > 0)
+		waitMilliSeconds(1);
+	delete pool;
+	EXPECT(d.executed == 500);
+	EXPECT(d.expired == 0);
+
+	// bounded queue and deadlines: block the only worker, then overfill the queue
+	d.executed = d.expired = 0;
+	pool = new ThreadPool("test", 1, 2);
+	EXPECT(pool->submit(blockingTask, &d, 0));
+	while (pool->getQueueLength() > 0)
+		waitMilliSeconds(1);
+	EXPECT(pool->submit(countingTask, &d, 1));
+	EXPECT(pool->submit(countingTask, &d, 0));
+	EXPECT(!pool->submit(countingTask, &d, 0));
+	EXPECT(pool->getQueueLength() == 2);
+	waitMilliSeconds(10);
+	sem_post(&d.blocker);
+	delete pool;
+	EXPECT(d.executed == 2);
+	EXPECT(d.expired == 1);
+
+	char stats[4096];
+	pool = new ThreadPool("test", 2, 10);
+	pool->getStatistics(stats, sizeof(stats));
+	EXPECT(strncmp(stats, "test: 2 workers", 15) == 0);
+	EXPECT(strstr(stats, "worker 1:") != NULL);
+	delete pool;
+	sem_destroy(&d.blocker);
+} // end of TESTCASE_ThreadPool(int*, int*)
+
 
@@ -1,7 +1,7 @@
 /**
  * author: Stefan Buettcher
  * created: 2007-11-18
- * changed: 2007-11-18
+ * changed: 2026-10-16
  **/
 
 
@@ -13,6 +13,7 @@
 
 
 REGISTER_TEST_CASE(StartsWithEndsWith);
+REGISTER_TEST_CASE(ThreadPool);
 
 
 #endif